@@ -6,18 +6,25 @@ echo Building winmm.dll...
 cl /LD /O2 /DNDEBUG ^
    winmm.cpp ^
    /link /OUT:winmm.dll gdi32.lib user32.lib
+if %errorlevel% neq 0 goto failed
 
-if %errorlevel% equ 0 (
-    echo.
-    echo Build successful!
-    echo Output: winmm.dll
-    echo.
-    echo Clean up intermediate files...
-    del *.obj >nul 2>&1
-    del *.exp >nul 2>&1
-    del *.lib >nul 2>&1
-    echo Done!
-) else (
-    echo.
-    echo Build failed!
-)
\ No newline at end of file
+echo Building tapreader.exe...
+cl /O2 /DNDEBUG ^
+   tapreader.cpp ^
+   /link /OUT:tapreader.exe
+if %errorlevel% neq 0 goto failed
+
+echo.
+echo Build successful!
+echo Output: winmm.dll, tapreader.exe
+echo.
+echo Clean up intermediate files...
+del *.obj >nul 2>&1
+del *.exp >nul 2>&1
+del *.lib >nul 2>&1
+echo Done!
+goto :eof
+
+:failed
+echo.
+echo Build failed!
\ No newline at end of file
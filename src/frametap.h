@@ -0,0 +1,116 @@
+// Shared-memory layout of the frame tap published by winmm.dll.
+//
+// The mapping starts with a FrameTapHeader followed by slotCount slots of
+// slotSize bytes. Frame N (counting from 1) is written to slot N % slotCount.
+// While the writer fills a slot its sequence is odd; once the frame is
+// complete it becomes 2*N and header->latest is set to N. Frame numbers and
+// sequences are unsigned 32-bit and wrap; frame 0 is skipped because
+// latest == 0 means no frame has been published yet.
+//
+// A reader takes latest, checks that the slot's sequence is 2*latest, uses
+// the pixels in place and then re-reads the sequence. If it changed the
+// writer lapped the reader and the frame must be discarded. The writer
+// never waits for readers.
+//
+// Alignment: the header, FrameTapSlot and slotSize are all multiples of 64
+// bytes and the mapping itself is page aligned, so every slot and its pixel
+// data start on a 64-byte boundary, ready for SIMD loads.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define FRAMETAP_NAME "Local\\GdiScalingFrameTap"
+#define FRAMETAP_MAGIC 0x50415446  // 'FTAP'
+#define FRAMETAP_VERSION 2  // 2: header and slot padded to 64 bytes
+
+// The counters are shared between processes, so they must be plain 32-bit words
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "frame tap counters must be 32-bit");
+#if ATOMIC_INT_LOCK_FREE != 2
+#error "frame tap needs lock-free 32-bit atomics"
+#endif
+
+struct FrameTapHeader {
+    std::atomic<uint32_t> magic;    // stored last, once the header is valid
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;              // bytes per slot, including FrameTapSlot
+    std::atomic<uint32_t> latest;   // number of the last complete frame (0 = none)
+    std::atomic<uint32_t> dropped;  // frames that didn't fit into a slot
+    uint32_t reserved[10];          // pads the header to 64 bytes
+};
+
+// Same layout as BITMAPINFOHEADER
+struct FrameTapFormat {
+    uint32_t size;
+    int32_t width;
+    int32_t height;                 // negative for top-down frames
+    uint16_t planes;
+    uint16_t bitCount;
+    uint32_t compression;           // BI_RGB or BI_BITFIELDS
+    uint32_t sizeImage;             // pixel data size in bytes
+    int32_t xPelsPerMeter;
+    int32_t yPelsPerMeter;
+    uint32_t clrUsed;
+    uint32_t clrImportant;
+};
+
+struct FrameTapSlot {
+    std::atomic<uint32_t> sequence; // odd while being written, 2*frame when complete
+    uint32_t usage;                 // DIB_RGB_COLORS or DIB_PAL_COLORS
+    FrameTapFormat format;
+    uint32_t colors[256];           // RGBQUAD palette, WORD indices, or the 3 bitfield masks
+    uint32_t reserved[4];           // pads the slot header to 1088 bytes
+    // pixel data follows, laid out exactly like the game's DIB
+};
+
+static_assert(sizeof(FrameTapHeader) % 64 == 0, "slots must start 64-byte aligned");
+static_assert(sizeof(FrameTapSlot) % 64 == 0, "pixel data must start 64-byte aligned");
+
+inline uint32_t FrameTapBusy(uint32_t frame) { return frame * 2u - 1u; }
+inline uint32_t FrameTapDone(uint32_t frame) { return frame * 2u; }
+inline uint32_t FrameTapNext(uint32_t frame) { return frame + 1u ? frame + 1u : 1u; }
+
+inline FrameTapSlot* FrameTapGetSlot(const FrameTapHeader* tap, uint32_t frame)
+{
+    return (FrameTapSlot*)((uint8_t*)tap + sizeof(FrameTapHeader) +
+                           (size_t)(frame % tap->slotCount) * tap->slotSize);
+}
+
+inline uint8_t* FrameTapPixels(const FrameTapSlot* slot)
+{
+    return (uint8_t*)slot + sizeof(FrameTapSlot);
+}
+
+// Writer: mark the slot busy before touching its contents...
+inline FrameTapSlot* FrameTapBeginWrite(FrameTapHeader* tap, uint32_t frame)
+{
+    FrameTapSlot* slot = FrameTapGetSlot(tap, frame);
+    slot->sequence.store(FrameTapBusy(frame), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot;
+}
+
+// ...and publish it once everything is written
+inline void FrameTapEndWrite(FrameTapHeader* tap, FrameTapSlot* slot, uint32_t frame)
+{
+    slot->sequence.store(FrameTapDone(frame), std::memory_order_release);
+    tap->latest.store(frame, std::memory_order_release);
+}
+
+// Reader: returns the slot if it currently holds the complete frame, else NULL
+inline const FrameTapSlot* FrameTapBeginRead(const FrameTapHeader* tap, uint32_t frame)
+{
+    const FrameTapSlot* slot = FrameTapGetSlot(tap, frame);
+    if (slot->sequence.load(std::memory_order_acquire) != FrameTapDone(frame)) return NULL;
+    return slot;
+}
+
+// True if the frame was not overwritten while it was being read. Anything
+// read from the slot since FrameTapBeginRead must be discarded otherwise.
+inline bool FrameTapEndRead(const FrameTapSlot* slot, uint32_t frame)
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence.load(std::memory_order_relaxed) == FrameTapDone(frame);
+}
@@ -0,0 +1,104 @@
+// Adaptive quality governor used by winmm.dll to pick the scaling tier.
+#pragma once
+
+#include <string.h>
+
+// Quality tiers from best looking to cheapest
+enum QualityTier {
+    TIER_SMOOTH,    // HALFTONE filtering
+    TIER_NEAREST,   // COLORONCOLOR nearest neighbour (the default)
+    TIER_INTEGER,   // nearest neighbour at a whole-number scale, smaller output
+    TIER_GDI,       // unscaled original SetDIBitsToDevice
+    TIER_COUNT
+};
+
+// Averages present cost over a moving window and steps between tiers to
+// hold a budget. Quality drops quickly when over budget but only rises after
+// a long stretch well under it. A step up stays on probation until the new
+// tier has lasted upAfter presents; falling back inside that span doubles the
+// wait. Every further upAfter presents the stepped-up tier holds halve it
+// again, so a tier whose cost hovers around the budget can't make the
+// governor flap, but a lasting drop in load is picked up again.
+#define GOVERNOR_WINDOW 32
+#define GOVERNOR_DOWN_AFTER 4      // presents with the window average over budget
+#define GOVERNOR_UP_AFTER 64       // presents with it under half the budget
+#define GOVERNOR_UP_MAX 4096
+
+struct Governor {
+    double budgetMs;
+    double samples[GOVERNOR_WINDOW];
+    double sum;
+    int count;
+    int next;
+    int tier;
+    int overStreak;
+    int underStreak;
+    int upAfter;        // current step-up wait, grows after failed step ups
+    int sinceUp;        // presents since the last step up, -1 once it stepped down
+    bool probation;     // stepped up and the new tier hasn't lasted upAfter presents yet
+};
+
+inline void GovernorReset(Governor& g, double budgetMs, int tier)
+{
+    memset(&g, 0, sizeof(g));
+    g.budgetMs = budgetMs;
+    g.tier = tier;
+    g.upAfter = GOVERNOR_UP_AFTER;
+    g.sinceUp = -1;
+}
+
+inline void GovernorSwitch(Governor& g, int tier)
+{
+    g.tier = tier;
+    g.sum = 0.0;
+    g.count = 0;
+    g.next = 0;
+    g.overStreak = 0;
+    g.underStreak = 0;
+}
+
+// Feed the cost of one present; returns the tier for the next one
+inline int GovernorUpdate(Governor& g, double costMs)
+{
+    if (g.count == GOVERNOR_WINDOW) {
+        g.sum -= g.samples[g.next];
+    } else {
+        g.count++;
+    }
+    g.samples[g.next] = costMs;
+    g.sum += costMs;
+    g.next = (g.next + 1) % GOVERNOR_WINDOW;
+
+    if (g.sinceUp >= 0 && ++g.sinceUp >= g.upAfter) {
+        g.probation = false;
+        g.upAfter = (g.upAfter / 2 > GOVERNOR_UP_AFTER) ? g.upAfter / 2 : GOVERNOR_UP_AFTER;
+        g.sinceUp = 0;
+    }
+
+    // Only judge a tier on a full window of its own samples
+    if (g.count < GOVERNOR_WINDOW) return g.tier;
+
+    double average = g.sum / GOVERNOR_WINDOW;
+    if (average > g.budgetMs) {
+        g.overStreak++;
+        g.underStreak = 0;
+    } else {
+        g.overStreak = 0;
+        g.underStreak = (average < g.budgetMs * 0.5) ? g.underStreak + 1 : 0;
+    }
+
+    if (g.overStreak >= GOVERNOR_DOWN_AFTER && g.tier < TIER_GDI) {
+        if (g.probation) {
+            g.probation = false;
+            g.upAfter = (g.upAfter * 2 < GOVERNOR_UP_MAX) ? g.upAfter * 2 : GOVERNOR_UP_MAX;
+        }
+        GovernorSwitch(g, g.tier + 1);
+        g.sinceUp = -1;
+    } else if (g.underStreak >= g.upAfter && g.tier > TIER_SMOOTH) {
+        GovernorSwitch(g, g.tier - 1);
+        g.probation = true;
+        g.sinceUp = 0;
+    }
+
+    return g.tier;
+}
@@ -0,0 +1,73 @@
+// BI_RLE8/BI_RLE4 decoder used by winmm.dll to expand RLE frames into its
+// cached index plane.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Decode a BI_RLE8/BI_RLE4 stream into the plane (bottom-up rows, like the DIB).
+// Writes are clipped to the plane and a truncated stream simply ends the frame.
+// Returns the number of pixels written.
+inline int DecodeRle(const uint8_t* src, size_t size, bool rle4,
+                     uint8_t* plane, int width, int height, int stride)
+{
+    size_t i = 0;
+    int x = 0;
+    int y = 0;
+    int written = 0;
+
+    while (i + 2 <= size && y < height) {
+        uint8_t count = src[i++];
+        uint8_t value = src[i++];
+
+        if (count) {
+            // Encoded run: one index repeated, or two alternating nibbles for RLE4
+            uint8_t* row = plane + y * stride;
+            int stop = (x + count < width) ? x + count : width;
+            if (!rle4) {
+                if (stop > x) memset(row + x, value, stop - x);
+            } else {
+                uint8_t pair[2] = { (uint8_t)(value >> 4), (uint8_t)(value & 0x0F) };
+                for (int p = x; p < stop; p++) row[p] = pair[(p - x) & 1];
+            }
+            if (stop > x) written += stop - x;
+            x = (x + count < width) ? x + count : width;
+            continue;
+        }
+
+        if (value == 0) {
+            // End of line
+            x = 0;
+            y++;
+        } else if (value == 1) {
+            // End of bitmap
+            break;
+        } else if (value == 2) {
+            // Delta: skipped pixels are left unchanged
+            if (i + 2 > size) break;
+            x += src[i++];
+            y += src[i++];
+            if (x > width) x = width;
+        } else {
+            // Absolute run of 'value' pixels, padded to a word boundary
+            size_t bytes = rle4 ? (value + 1) / 2 : value;
+            if (i + bytes > size) break;
+            uint8_t* row = plane + y * stride;
+            int stop = (x + value < width) ? x + value : width;
+            if (!rle4) {
+                if (stop > x) memcpy(row + x, src + i, stop - x);
+            } else {
+                for (int p = x; p < stop; p++) {
+                    uint8_t b = src[i + (p - x) / 2];
+                    row[p] = ((p - x) & 1) ? (b & 0x0F) : (b >> 4);
+                }
+            }
+            if (stop > x) written += stop - x;
+            x = (x + value < width) ? x + value : width;
+            i += bytes + (bytes & 1);
+        }
+    }
+
+    return written;
+}
@@ -0,0 +1,96 @@
+// Nearest-neighbour scaler core used by winmm.dll for large frames.
+//
+// The output is 32bpp, top-down, 16-byte aligned, with rows padded to a
+// multiple of 4 pixels. The non-temporal variant writes it with streaming
+// stores that bypass the cache: the scaled frame is written once and only
+// read back by the blit, so keeping it out of the cache leaves the source
+// frame, palette and column map resident instead of evicting them.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <emmintrin.h>
+
+// Source frame as laid out in the DIB
+struct StreamSource {
+    const uint8_t* bits;
+    int stride;                 // bytes per row
+    int width;
+    int height;
+    int bitCount;               // 8 (indexed through palette) or 32
+    bool bottomUp;
+    const uint32_t* palette;    // 256 0x00RRGGBB entries for 8bpp sources
+};
+
+// Source column for each of the stride output columns, sampled at pixel
+// centres; -1 for the border outside [dstX, dstX + dstWidth)
+inline void BuildStreamColumns(int* columns, int stride, int srcWidth, int dstX, int dstWidth)
+{
+    for (int x = 0; x < stride; x++) {
+        int dx = x - dstX;
+        columns[x] = (dx < 0 || dx >= dstWidth) ? -1 :
+            (int)(((2LL * dx + 1) * srcWidth) / (2LL * dstWidth));
+    }
+}
+
+inline uint32_t StreamPixel8(const uint8_t* row, const uint32_t* palette, int column)
+{
+    return (column < 0) ? 0 : palette[row[column]];
+}
+
+inline uint32_t StreamPixel32(const uint8_t* row, int column)
+{
+    return (column < 0) ? 0 : ((const uint32_t*)row)[column];
+}
+
+template <bool NonTemporal>
+inline void StreamStore(__m128i* out, __m128i value)
+{
+    if (NonTemporal) {
+        _mm_stream_si128(out, value);
+    } else {
+        _mm_store_si128(out, value);
+    }
+}
+
+// Scale output rows [top, bottom). The frame covers rows [dstY, dstY +
+// dstHeight) and the columns mapped by BuildStreamColumns; the rest is black.
+template <bool NonTemporal>
+void ScaleNearestRows(const StreamSource& src, const int* columns, uint32_t* out, int outStride,
+                      int dstY, int dstHeight, int top, int bottom)
+{
+    const __m128i black = _mm_setzero_si128();
+
+    for (int y = top; y < bottom; y++) {
+        __m128i* row128 = (__m128i*)(out + (size_t)y * outStride);
+        int dy = y - dstY;
+
+        if (dy < 0 || dy >= dstHeight) {
+            for (int i = 0; i < outStride / 4; i++) StreamStore<NonTemporal>(row128 + i, black);
+            continue;
+        }
+
+        int sy = (int)(((2LL * dy + 1) * src.height) / (2LL * dstHeight));
+        if (src.bottomUp) sy = src.height - 1 - sy;
+        const uint8_t* row = src.bits + (size_t)sy * src.stride;
+        const int* col = columns;
+
+        if (src.bitCount == 8) {
+            for (int x = 0; x < outStride; x += 4) {
+                StreamStore<NonTemporal>(row128 + x / 4, _mm_setr_epi32(
+                    StreamPixel8(row, src.palette, col[x]), StreamPixel8(row, src.palette, col[x + 1]),
+                    StreamPixel8(row, src.palette, col[x + 2]), StreamPixel8(row, src.palette, col[x + 3])));
+            }
+        } else {
+            for (int x = 0; x < outStride; x += 4) {
+                StreamStore<NonTemporal>(row128 + x / 4, _mm_setr_epi32(
+                    StreamPixel32(row, col[x]), StreamPixel32(row, col[x + 1]),
+                    StreamPixel32(row, col[x + 2]), StreamPixel32(row, col[x + 3])));
+            }
+        }
+    }
+
+    // Non-temporal stores are weakly ordered: make them visible before the
+    // rows are handed to the blit
+    if (NonTemporal) _mm_sfence();
+}
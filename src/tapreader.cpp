@@ -0,0 +1,87 @@
+// Reference reader for the winmm.dll frame tap (see frametap.h).
+// Follows the newest frame, reads its pixels straight out of the shared
+// ring and prints a line per second with the frame format and statistics.
+//
+// Usage: tapreader [mapping name]
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <stdio.h>
+#include "frametap.h"
+
+// Stand-in for an encoder: consumes the pixels in place
+uint32_t Checksum(const uint8_t* data, DWORD size)
+{
+    uint32_t sum = 0;
+    for (DWORD i = 0; i < size; i++) {
+        sum = sum * 31 + data[i];
+    }
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    const char* name = (argc > 1) ? argv[1] : FRAMETAP_NAME;
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!mapping) {
+        printf("Frame tap '%s' not found (is FrameTap enabled in winmm.ini?)\n", name);
+        return 1;
+    }
+
+    const FrameTapHeader* tap = (const FrameTapHeader*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!tap || tap->magic.load(std::memory_order_acquire) != FRAMETAP_MAGIC ||
+        tap->version != FRAMETAP_VERSION) {
+        printf("Frame tap '%s' has an unknown layout\n", name);
+        return 1;
+    }
+
+    printf("Reading '%s': %u slots of %u bytes\n", name, tap->slotCount, tap->slotSize);
+
+    uint32_t lastFrame = 0;
+    DWORD frames = 0;
+    DWORD skipped = 0;
+    DWORD torn = 0;
+    DWORD lastReport = GetTickCount();
+
+    for (;;) {
+        uint32_t frame = tap->latest.load(std::memory_order_acquire);
+        if (frame == lastFrame) {
+            Sleep(1);
+            continue;
+        }
+
+        // The slot must still hold this frame before and after we use it
+        const FrameTapSlot* slot = FrameTapBeginRead(tap, frame);
+        if (!slot) {
+            continue;
+        }
+
+        FrameTapFormat format = slot->format;
+        uint32_t sum = 0;
+        if (format.sizeImage <= tap->slotSize - sizeof(FrameTapSlot)) {
+            sum = Checksum(FrameTapPixels(slot), format.sizeImage);
+        }
+
+        if (!FrameTapEndRead(slot, frame)) {
+            torn++;
+            continue;
+        }
+
+        // Unsigned difference stays right across the counter wrap
+        if (lastFrame && frame - lastFrame > 1) {
+            skipped += frame - lastFrame - 1;
+        }
+        lastFrame = frame;
+        frames++;
+
+        DWORD now = GetTickCount();
+        if (now - lastReport >= 1000) {
+            printf("frame %u: %dx%d %ubpp, %lu fps, %lu skipped, %lu torn, %u dropped, sum %08x\n",
+                   frame, format.width, format.height, format.bitCount,
+                   frames, skipped, torn, tap->dropped.load(std::memory_order_relaxed), sum);
+            frames = skipped = torn = 0;
+            lastReport = now;
+        }
+    }
+}
@@ -14,6 +14,12 @@
 #include <windows.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <emmintrin.h>
+#include "frametap.h"
+#include "governor.h"
+#include "rle.h"
+#include "stream.h"
 
 typedef int (WINAPI *SetDIBitsToDevice_t)(
     HDC,int,int,DWORD,DWORD,int,int,UINT,UINT,const VOID*,const BITMAPINFO*,UINT);
@@ -22,6 +28,55 @@ void* tSDTD;  // trampoline for original function
 HWND gameWindow = NULL;
 bool windowResized = false;
 HMODULE hOriginalWinmm = NULL;
+HMODULE hThisModule = NULL;
+
+// Settings are read from winmm.ini next to this DLL
+char settingsPath[MAX_PATH] = "";
+bool frameTapEnabled = false;
+int frameTapSlots = 3;
+int frameTapMaxBytes = 1024 * 768 * 4;
+char frameTapName[MAX_PATH] = FRAMETAP_NAME;
+bool overlayEnabled = false;
+bool overlayVisible = false;
+int overlayHotkey = VK_F11;
+bool governorEnabled = false;
+int governorBudgetMs = 8;
+bool pipelineEnabled = false;
+int pipelineStrips = 8;
+bool pipelineReport = false;
+bool streamEnabled = true;
+int streamThresholdBytes = 8 * 1024 * 1024;
+
+void LoadSettings()
+{
+    DWORD len = GetModuleFileNameA(hThisModule, settingsPath, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) return;
+
+    // Replace the file name with winmm.ini
+    char* slash = settingsPath + len;
+    while (slash > settingsPath && slash[-1] != '\\') slash--;
+    if ((slash - settingsPath) + 10 > MAX_PATH) return;
+    lstrcpyA(slash, "winmm.ini");
+
+    frameTapEnabled = GetPrivateProfileIntA("FrameTap", "Enabled", 0, settingsPath) != 0;
+    frameTapSlots = GetPrivateProfileIntA("FrameTap", "Slots", frameTapSlots, settingsPath);
+    frameTapMaxBytes = GetPrivateProfileIntA("FrameTap", "MaxFrameBytes", frameTapMaxBytes, settingsPath);
+    GetPrivateProfileStringA("FrameTap", "Name", FRAMETAP_NAME, frameTapName, MAX_PATH, settingsPath);
+
+    overlayEnabled = GetPrivateProfileIntA("Overlay", "Enabled", 0, settingsPath) != 0;
+    overlayVisible = GetPrivateProfileIntA("Overlay", "Visible", 0, settingsPath) != 0;
+    overlayHotkey = GetPrivateProfileIntA("Overlay", "Hotkey", overlayHotkey, settingsPath);
+
+    governorEnabled = GetPrivateProfileIntA("Governor", "Enabled", 0, settingsPath) != 0;
+    governorBudgetMs = GetPrivateProfileIntA("Governor", "BudgetMs", governorBudgetMs, settingsPath);
+
+    pipelineEnabled = GetPrivateProfileIntA("Pipeline", "Enabled", 0, settingsPath) != 0;
+    pipelineStrips = GetPrivateProfileIntA("Pipeline", "Strips", pipelineStrips, settingsPath);
+    pipelineReport = GetPrivateProfileIntA("Pipeline", "Report", 0, settingsPath) != 0;
+
+    streamEnabled = GetPrivateProfileIntA("Streaming", "Enabled", 1, settingsPath) != 0;
+    streamThresholdBytes = GetPrivateProfileIntA("Streaming", "ThresholdBytes", streamThresholdBytes, settingsPath);
+}
 
 // Get screen dimensions
 int GetScreenWidth() {
@@ -71,6 +126,763 @@ void ResizeGameWindow() {
     }
 }
 
+// Cached 8bpp index plane that BI_RLE8/BI_RLE4 frames are decoded into.
+// It persists between frames so delta-skipped pixels keep their old value.
+struct RleBitmapInfo {
+    BITMAPINFOHEADER bmiHeader;
+    RGBQUAD bmiColors[256];
+};
+
+uint8_t* rlePlane = NULL;
+int rleWidth = 0;
+int rleHeight = 0;
+int rleStride = 0;
+RleBitmapInfo rleInfo;
+UINT rleUsage = DIB_RGB_COLORS;
+
+// Decode an RLE frame into the cached plane and describe it as an uncompressed
+// 8bpp DIB in rleInfo. 'changed' is false when the frame didn't touch any pixel.
+// Returns false if the frame can't be decoded and GDI should handle it.
+bool DecodeRleFrame(const BITMAPINFO* bmi, const VOID* bits, UINT usage, bool* changed)
+{
+    const BITMAPINFOHEADER& h = bmi->bmiHeader;
+    bool rle4 = (h.biCompression == BI_RLE4);
+
+    // RLE bitmaps are always bottom-up and must carry their compressed size
+    if (!bits || h.biWidth <= 0 || h.biHeight <= 0 || h.biSizeImage == 0) {
+        return false;
+    }
+
+    bool reallocated = false;
+    if (h.biWidth != rleWidth || h.biHeight != rleHeight) {
+        free(rlePlane);
+        rleStride = (h.biWidth + 3) & ~3;
+        rlePlane = (uint8_t*)calloc((size_t)rleStride * h.biHeight, 1);
+        if (!rlePlane) {
+            rleWidth = rleHeight = 0;
+            return false;
+        }
+        rleWidth = h.biWidth;
+        rleHeight = h.biHeight;
+        reallocated = true;
+    }
+
+    int written = DecodeRle((const uint8_t*)bits, h.biSizeImage, rle4,
+                            rlePlane, rleWidth, rleHeight, rleStride);
+
+    // Copy the palette (RGBQUADs or WORD indices for DIB_PAL_COLORS). A frame
+    // that only changes the palette (fades, colour cycling) still has to be shown.
+    DWORD colors = h.biClrUsed ? h.biClrUsed : (rle4 ? 16 : 256);
+    if (colors > 256) colors = 256;
+    const uint8_t* palette = (const uint8_t*)bmi + h.biSize;
+    size_t paletteBytes = colors * (usage == DIB_PAL_COLORS ? sizeof(WORD) : sizeof(RGBQUAD));
+    bool paletteChanged = colors != rleInfo.bmiHeader.biClrUsed || usage != rleUsage ||
+                          memcmp(rleInfo.bmiColors, palette, paletteBytes) != 0;
+    if (paletteChanged) {
+        memcpy(rleInfo.bmiColors, palette, paletteBytes);
+        rleUsage = usage;
+    }
+
+    *changed = reallocated || paletteChanged || written > 0;
+
+    rleInfo.bmiHeader = h;
+    rleInfo.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    rleInfo.bmiHeader.biBitCount = 8;
+    rleInfo.bmiHeader.biCompression = BI_RGB;
+    rleInfo.bmiHeader.biSizeImage = 0;
+    rleInfo.bmiHeader.biClrUsed = colors;
+    rleInfo.bmiHeader.biClrImportant = 0;
+    return true;
+}
+
+// Optional frame tap: publishes each native-resolution source frame into a
+// shared-memory ring (see frametap.h) for external capture and streaming tools
+#define FRAMETAP_MAX_TOTAL (1ull << 30)  // refuse mappings above 1 GB
+
+static_assert(sizeof(FrameTapFormat) == sizeof(BITMAPINFOHEADER), "FrameTapFormat mirrors BITMAPINFOHEADER");
+
+HANDLE frameTapMapping = NULL;
+FrameTapHeader* frameTap = NULL;
+uint32_t frameTapFrame = 0;
+
+void CloseFrameTap()
+{
+    if (frameTap) UnmapViewOfFile(frameTap);
+    if (frameTapMapping) CloseHandle(frameTapMapping);
+    frameTap = NULL;
+    frameTapMapping = NULL;
+}
+
+void OpenFrameTap()
+{
+    if (frameTapSlots < 1 || frameTapMaxBytes <= 0) return;
+
+    // Slots are a multiple of 64 bytes so each one, like the header, stays
+    // cache-line aligned (see frametap.h). Sizes are 64-bit so large ini
+    // values can't wrap into a small mapping.
+    uint64_t slotSize = ((uint64_t)sizeof(FrameTapSlot) + (uint64_t)frameTapMaxBytes + 63) & ~63ull;
+    uint64_t total = sizeof(FrameTapHeader) + (uint64_t)frameTapSlots * slotSize;
+    if (total > FRAMETAP_MAX_TOTAL) return;
+
+    frameTapMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                         (DWORD)(total >> 32), (DWORD)total, frameTapName);
+    if (!frameTapMapping) return;
+    bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+    // Mapping an existing section that is smaller than total fails here
+    frameTap = (FrameTapHeader*)MapViewOfFile(frameTapMapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)total);
+    if (!frameTap) {
+        CloseFrameTap();
+        return;
+    }
+
+    // A reader kept the ring of an earlier run open. Reuse it if the layout
+    // matches and carry on numbering frames after its latest one; never
+    // write into a mapping with a different layout.
+    if (existed) {
+        if (frameTap->magic.load(std::memory_order_acquire) != FRAMETAP_MAGIC ||
+            frameTap->version != FRAMETAP_VERSION ||
+            frameTap->slotCount != (uint32_t)frameTapSlots ||
+            frameTap->slotSize != (uint32_t)slotSize) {
+            CloseFrameTap();
+            return;
+        }
+        frameTapFrame = frameTap->latest.load(std::memory_order_relaxed);
+        return;
+    }
+
+    frameTap->slotCount = frameTapSlots;
+    frameTap->slotSize = (uint32_t)slotSize;
+    frameTap->latest.store(0, std::memory_order_relaxed);
+    frameTap->dropped.store(0, std::memory_order_relaxed);
+    frameTap->version = FRAMETAP_VERSION;
+    frameTap->magic.store(FRAMETAP_MAGIC, std::memory_order_release);
+}
+
+// Copy one uncompressed frame into the next slot. Never waits for readers.
+void PublishFrame(const VOID* bits, const BITMAPINFO* bmi, UINT usage)
+{
+    if (!frameTap || !bits || !bmi) return;
+
+    const BITMAPINFOHEADER& h = bmi->bmiHeader;
+    if (h.biCompression != BI_RGB && h.biCompression != BI_BITFIELDS) return;
+    if (h.biWidth <= 0 || h.biHeight == 0) return;
+
+    uint64_t stride = (((uint64_t)h.biWidth * h.biBitCount + 31) / 32) * 4;
+    uint64_t size = stride * (uint64_t)(h.biHeight < 0 ? -(int64_t)h.biHeight : h.biHeight);
+    if (size > frameTap->slotSize - sizeof(FrameTapSlot)) {
+        frameTap->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    frameTapFrame = FrameTapNext(frameTapFrame);
+    FrameTapSlot* slot = FrameTapBeginWrite(frameTap, frameTapFrame);
+
+    slot->usage = usage;
+    memcpy(&slot->format, &h, sizeof(FrameTapFormat));
+    slot->format.size = sizeof(FrameTapFormat);
+    slot->format.sizeImage = (uint32_t)size;
+
+    // Palette follows the header; bitfield masks always sit right after the
+    // first 40 bytes, even for V4/V5 headers
+    if (h.biBitCount <= 8) {
+        DWORD colors = h.biClrUsed ? h.biClrUsed : (1u << h.biBitCount);
+        if (colors > 256) colors = 256;
+        memcpy(slot->colors, (const uint8_t*)bmi + h.biSize,
+               colors * (usage == DIB_PAL_COLORS ? sizeof(WORD) : sizeof(RGBQUAD)));
+        slot->format.clrUsed = colors;
+    } else if (h.biCompression == BI_BITFIELDS) {
+        memcpy(slot->colors, (const uint8_t*)bmi + sizeof(BITMAPINFOHEADER), 3 * sizeof(DWORD));
+    }
+
+    memcpy(FrameTapPixels(slot), bits, (size_t)size);
+
+    FrameTapEndWrite(frameTap, slot, frameTapFrame);
+}
+
+// Cached 32bpp top-down back buffer the scaled frame is composed in.
+// As a DIB section its pixels can also be written directly. Rows are padded
+// to a multiple of 16 bytes so every row starts aligned for SSE2 stores.
+HDC backDC = NULL;
+HBITMAP backBitmap = NULL;
+HBITMAP backOldBitmap = NULL;
+uint32_t* backBits = NULL;
+int backWidth = 0;
+int backHeight = 0;
+int backStride = 0;     // pixels per row
+
+bool EnsureBackBuffer(HDC hdc, int width, int height)
+{
+    if (backBitmap && width == backWidth && height == backHeight) return true;
+
+    if (!backDC) {
+        backDC = CreateCompatibleDC(hdc);
+        if (!backDC) return false;
+    }
+
+    if (backBitmap) {
+        SelectObject(backDC, backOldBitmap);
+        DeleteObject(backBitmap);
+        backBitmap = NULL;
+        backBits = NULL;
+    }
+
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = (width + 3) & ~3;
+    info.bmiHeader.biHeight = -height;  // top-down
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    void* pixels = NULL;
+    backBitmap = CreateDIBSection(backDC, &info, DIB_RGB_COLORS, &pixels, NULL, 0);
+    if (!backBitmap) return false;
+
+    backOldBitmap = (HBITMAP)SelectObject(backDC, backBitmap);
+    backBits = (uint32_t*)pixels;
+    backWidth = width;
+    backHeight = height;
+    backStride = info.bmiHeader.biWidth;
+    return true;
+}
+
+// Adaptive quality governor (see governor.h)
+Governor governor;
+int presentedTier = TIER_NEAREST;  // tier of the last present
+
+// Timing of the scaled present path, shown by the overlay
+struct FrameStats {
+    double frameMs;     // time between presents
+    double scaleMs;     // StretchDIBits into the back buffer
+    double presentMs;   // whole scaled present, including overlay and blit
+    double overlayMs;   // drawing the overlay itself
+    DWORD dropped;      // presents that came over 1.5x the average interval late
+};
+
+FrameStats frameStats;
+LONGLONG lastPresentTime = 0;
+double qpcToMs = 0.0;
+
+LONGLONG Now()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t.QuadPart;
+}
+
+double ElapsedMs(LONGLONG from, LONGLONG to)
+{
+    if (qpcToMs == 0.0) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        qpcToMs = 1000.0 / (double)freq.QuadPart;
+    }
+    return (double)(to - from) * qpcToMs;
+}
+
+// Exponential moving average so the numbers stay readable
+void Smooth(double& average, double sample)
+{
+    average = (average == 0.0) ? sample : average + (sample - average) * 0.1;
+}
+
+void UpdateFrameStats(LONGLONG start, LONGLONG scaled, LONGLONG end)
+{
+    if (governorEnabled) {
+        GovernorUpdate(governor, ElapsedMs(start, end));
+    }
+
+    if (lastPresentTime) {
+        double interval = ElapsedMs(lastPresentTime, start);
+        if (frameStats.frameMs > 0.0 && interval > frameStats.frameMs * 1.5) {
+            frameStats.dropped++;
+        }
+        Smooth(frameStats.frameMs, interval);
+    }
+    lastPresentTime = start;
+
+    Smooth(frameStats.scaleMs, ElapsedMs(start, scaled));
+    Smooth(frameStats.presentMs, ElapsedMs(start, end));
+}
+
+// Performance overlay: a 5x7 font pre-rasterised into a mask atlas at the
+// current scale, blended with SSE2 into only the back buffer rows it covers
+const char overlayChars[] = "0123456789. CDFOPQRSTV";
+const uint8_t overlayFont[][7] = {
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },  // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },  // 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },  // 2
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },  // 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },  // 4
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },  // 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },  // 6
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },  // 8
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },  // 9
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },  // .
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // space
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },  // C
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },  // D
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },  // F
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },  // O
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },  // P
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },  // Q
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },  // R
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },  // S
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },  // V
+};
+
+const int overlayMaxChars = 9;  // "FT 999.99"
+uint32_t* overlayAtlas = NULL;  // one mask per pixel: 0 or 0xFFFFFFFF
+int overlayScale = 0;
+bool overlayKeyDown = false;
+
+void BuildOverlayAtlas(int scale)
+{
+    int cellW = 6 * scale;
+    int cellH = 7 * scale;
+    int glyphs = sizeof(overlayFont) / sizeof(overlayFont[0]);
+
+    uint32_t* atlas = (uint32_t*)malloc(glyphs * cellW * cellH * sizeof(uint32_t));
+    if (!atlas) return;
+
+    for (int g = 0; g < glyphs; g++) {
+        for (int y = 0; y < cellH; y++) {
+            for (int x = 0; x < cellW; x++) {
+                int fx = x / scale;
+                bool on = fx < 5 && ((overlayFont[g][y / scale] >> (4 - fx)) & 1);
+                atlas[(g * cellH + y) * cellW + x] = on ? 0xFFFFFFFF : 0;
+            }
+        }
+    }
+
+    free(overlayAtlas);
+    overlayAtlas = atlas;
+    overlayScale = scale;
+}
+
+// Darken 'count' pixels to half and paint them white wherever 'mask' is set
+void BlendOverlaySpan(uint32_t* dst, const uint32_t* mask, int count)
+{
+    const __m128i half = _mm_set1_epi32(0x007F7F7F);
+    const __m128i white = _mm_set1_epi32(0x00FFFFFF);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i out = _mm_and_si128(_mm_srli_epi32(px, 1), half);
+        if (mask) {
+            __m128i m = _mm_loadu_si128((const __m128i*)(mask + i));
+            out = _mm_or_si128(_mm_and_si128(m, white), _mm_andnot_si128(m, out));
+        }
+        _mm_storeu_si128((__m128i*)(dst + i), out);
+    }
+    for (; i < count; i++) {
+        dst[i] = (mask && mask[i]) ? 0x00FFFFFF : (dst[i] >> 1) & 0x007F7F7F;
+    }
+}
+
+// wsprintf has no %f, so format milliseconds with two decimals by hand
+void FormatStat(char* line, const char* label, double ms)
+{
+    int hundredths = (ms < 999.99) ? (int)(ms * 100.0 + 0.5) : 99999;
+    wsprintfA(line, "%s %d.%02d", label, hundredths / 100, hundredths % 100);
+}
+
+// Toggle the overlay on the hotkey's press edge
+void PollOverlayHotkey()
+{
+    bool down = (GetAsyncKeyState(overlayHotkey) & 0x8000) != 0;
+    if (down && !overlayKeyDown) overlayVisible = !overlayVisible;
+    overlayKeyDown = down;
+}
+
+// Draw the part of the overlay that falls in rows [top, bottom).
+// Returns the time it took in milliseconds.
+double DrawOverlay(uint32_t* bits, int stride, int width, int height, int top, int bottom)
+{
+    LONGLONG start = Now();
+
+    int scale = (height / 360 > 2) ? height / 360 : 2;
+    if (scale != overlayScale) BuildOverlayAtlas(scale);
+    if (!overlayAtlas) return 0.0;
+
+    char lines[6][16];
+    FormatStat(lines[0], "FT", frameStats.frameMs);
+    FormatStat(lines[1], "SC", frameStats.scaleMs);
+    FormatStat(lines[2], "PR", frameStats.presentMs);
+    wsprintfA(lines[3], "DR %lu", frameStats.dropped < 999999 ? frameStats.dropped : 999999);
+    FormatStat(lines[4], "OV", frameStats.overlayMs);
+    wsprintfA(lines[5], "QT %d", governorEnabled ? governor.tier : (int)TIER_NEAREST);
+    const int lineCount = 6;
+
+    int cellW = 6 * scale;
+    int cellH = 7 * scale;
+    int lineH = 9 * scale;
+    int pad = 2 * scale;
+    int boxX = 4 * scale;
+    int boxY = 4 * scale;
+    int boxW = 2 * pad + overlayMaxChars * cellW;
+    int boxH = 2 * pad + lineCount * lineH - (lineH - cellH);
+    if (boxX + boxW > width || boxY + boxH > height) return 0.0;
+
+    int first = (top > boxY) ? top - boxY : 0;
+    int last = (bottom < boxY + boxH) ? bottom - boxY : boxH;
+    for (int y = first; y < last; y++) {
+        uint32_t* row = bits + (size_t)(boxY + y) * stride + boxX;
+        int ty = y - pad;
+        int line = (ty >= 0) ? ty / lineH : lineCount;
+        int gy = (ty >= 0) ? ty % lineH : cellH;
+
+        // Rows between text lines only darken the box
+        if (line >= lineCount || gy >= cellH) {
+            BlendOverlaySpan(row, NULL, boxW);
+            continue;
+        }
+
+        BlendOverlaySpan(row, NULL, pad);
+        int x = pad;
+        for (int i = 0; lines[line][i] && i < overlayMaxChars; i++, x += cellW) {
+            const char* glyph = strchr(overlayChars, lines[line][i]);
+            const uint32_t* mask = glyph ?
+                overlayAtlas + ((glyph - overlayChars) * cellH + gy) * cellW : NULL;
+            BlendOverlaySpan(row + x, mask, cellW);
+        }
+        BlendOverlaySpan(row + x, NULL, boxW - x);
+    }
+
+    return ElapsedMs(start, Now());
+}
+
+// Everything needed to scale one frame into the back buffer
+struct ScaleJob {
+    const VOID* bits;
+    const BITMAPINFO* bmi;
+    UINT usage;
+    int srcWidth;
+    int srcHeight;
+    int dstX;
+    int dstY;
+    int dstWidth;
+    int dstHeight;
+    int width;          // window and back buffer size
+    int height;
+    int tier;
+    bool overlay;
+    bool stream;        // use the streaming-store scaler instead of GDI
+};
+
+// Nearest-neighbour scaler for large frames that writes the back buffer with
+// non-temporal SSE2 stores (see stream.h). Handles 8bpp (DIB_RGB_COLORS) and
+// 32bpp BI_RGB sources. The column map is rebuilt only when the geometry
+// changes and the palette only when the source colour table does.
+int* streamColumns = NULL;      // source column per back buffer column, -1 = border
+int streamColumnsSrc = 0;
+int streamColumnsX = 0;
+int streamColumnsWidth = 0;
+int streamColumnsStride = 0;
+uint32_t streamPalette[256];
+RGBQUAD streamPaletteSource[256];   // colour table streamPalette was built from
+DWORD streamPaletteColors = 0;      // 0 = not built yet
+
+// Decide whether the job can be streamed and prepare the column map and
+// palette for it. Runs on the hook thread before any rows are scaled.
+bool PrepareStreaming(const ScaleJob& job)
+{
+    if (!streamEnabled || !job.bits || !job.bmi) return false;
+    if ((size_t)backStride * job.height * 4 < (size_t)streamThresholdBytes) return false;
+    if (job.tier != TIER_NEAREST && job.tier != TIER_INTEGER) return false;
+
+    const BITMAPINFOHEADER& h = job.bmi->bmiHeader;
+    if (h.biWidth != job.srcWidth || abs(h.biHeight) != job.srcHeight) return false;
+    if (h.biCompression != BI_RGB) return false;
+    if (h.biBitCount == 8 && job.usage != DIB_RGB_COLORS) return false;
+    if (h.biBitCount != 8 && h.biBitCount != 32) return false;
+
+    if (!streamColumns || streamColumnsSrc != job.srcWidth || streamColumnsX != job.dstX ||
+        streamColumnsWidth != job.dstWidth || streamColumnsStride != backStride) {
+        int* columns = (int*)malloc(backStride * sizeof(int));
+        if (!columns) return false;
+        BuildStreamColumns(columns, backStride, job.srcWidth, job.dstX, job.dstWidth);
+
+        free(streamColumns);
+        streamColumns = columns;
+        streamColumnsSrc = job.srcWidth;
+        streamColumnsX = job.dstX;
+        streamColumnsWidth = job.dstWidth;
+        streamColumnsStride = backStride;
+    }
+
+    if (h.biBitCount == 8) {
+        DWORD colors = h.biClrUsed ? h.biClrUsed : 256;
+        if (colors > 256) colors = 256;
+        const RGBQUAD* palette = (const RGBQUAD*)((const uint8_t*)job.bmi + h.biSize);
+        if (colors != streamPaletteColors ||
+            memcmp(streamPaletteSource, palette, colors * sizeof(RGBQUAD)) != 0) {
+            memcpy(streamPaletteSource, palette, colors * sizeof(RGBQUAD));
+            streamPaletteColors = colors;
+            memset(streamPalette, 0, sizeof(streamPalette));
+            for (DWORD i = 0; i < colors; i++) {
+                streamPalette[i] = (palette[i].rgbRed << 16) | (palette[i].rgbGreen << 8) | palette[i].rgbBlue;
+            }
+        }
+    }
+
+    return true;
+}
+
+void StreamRows(const ScaleJob& job, int top, int bottom)
+{
+    // GDI may still have batched drawing into the DIB section queued
+    GdiFlush();
+
+    const BITMAPINFOHEADER& h = job.bmi->bmiHeader;
+    StreamSource src;
+    src.bits = (const uint8_t*)job.bits;
+    src.stride = ((h.biWidth * h.biBitCount + 31) / 32) * 4;
+    src.width = job.srcWidth;
+    src.height = job.srcHeight;
+    src.bitCount = h.biBitCount;
+    src.bottomUp = h.biHeight > 0;
+    src.palette = streamPalette;
+
+    ScaleNearestRows<true>(src, streamColumns, backBits, backStride, job.dstY, job.dstHeight, top, bottom);
+}
+
+// Scale into back buffer rows [top, bottom); GDI is clipped to those rows
+void ScaleRows(const ScaleJob& job, int top, int bottom)
+{
+    if (job.stream) {
+        StreamRows(job, top, bottom);
+        return;
+    }
+
+    SelectClipRgn(backDC, NULL);
+    IntersectClipRect(backDC, 0, top, job.width, bottom);
+
+    // Fill background with black in memory DC
+    RECT rect = {0, top, job.width, bottom};
+    FillRect(backDC, &rect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+
+    // Draw scaled image to memory DC
+    if (job.tier == TIER_SMOOTH) {
+        SetStretchBltMode(backDC, HALFTONE);
+        SetBrushOrgEx(backDC, 0, 0, NULL);  // Required after selecting HALFTONE
+    } else {
+        SetStretchBltMode(backDC, COLORONCOLOR);  // Faster, better for pixel art
+    }
+
+    StretchDIBits(
+        backDC,
+        job.dstX, job.dstY,
+        job.dstWidth, job.dstHeight,
+        0, 0,  // Use full source bitmap
+        job.srcWidth, job.srcHeight,
+        job.bits,
+        job.bmi,
+        job.usage,
+        SRCCOPY
+    );
+}
+
+// Pipelined present: a worker thread scales the frame in horizontal strips
+// while the hook thread blits each finished strip, so the top of the frame
+// reaches the screen while the bottom is still being scaled. Finished strips
+// are handed over through a bounded single-producer/single-consumer ring.
+// The worker only touches backDC while the hook thread waits on strips.
+#define PIPELINE_MAX_STRIPS 32
+#define PIPELINE_QUEUE 4
+#define PIPELINE_REPORT_FRAMES 300
+
+struct StripDone {
+    int strip;
+    LONGLONG scaleStart;    // ScaleRows of this strip, timed on the worker
+    LONGLONG scaleEnd;
+};
+
+// head and tail only ever increase; unsigned differences stay correct
+// when they wrap
+struct StripQueue {
+    volatile ULONG head;    // advanced by the scale thread
+    volatile ULONG tail;    // advanced by the blit thread
+    StripDone items[PIPELINE_QUEUE];
+};
+static_assert((PIPELINE_QUEUE & (PIPELINE_QUEUE - 1)) == 0, "PIPELINE_QUEUE must be a power of two");
+
+// Per-strip and end-to-end times in QPC ticks, summed between reports
+struct PipelineTimes {
+    LONGLONG scale[PIPELINE_MAX_STRIPS];
+    LONGLONG blit[PIPELINE_MAX_STRIPS];
+    LONGLONG firstShown;
+    LONGLONG done;
+    int frames;
+};
+
+StripQueue stripQueue;
+ScaleJob pipelineJob;
+double pipelineOverlayMs = 0.0;
+PipelineTimes pipelineTimes;
+HANDLE pipelineStart = NULL;
+HANDLE pipelineWorker = NULL;
+HANDLE stripPushed = NULL;      // auto-reset, set after every PushStrip
+HANDLE stripPopped = NULL;      // auto-reset, set after every PopStrip
+
+// Strips are usually handed over within a few microseconds, so spin a little
+// first, then block until the other side moves the queue. An auto-reset
+// event stays set until a wait consumes it, so a hand-over between the
+// caller's check and the wait isn't lost; stale wakes just re-check.
+void SpinPause(int& spins, HANDLE wake)
+{
+    if (++spins < 64) {
+        YieldProcessor();
+    } else {
+        WaitForSingleObject(wake, INFINITE);
+    }
+}
+
+void PushStrip(int strip, LONGLONG scaleStart, LONGLONG scaleEnd)
+{
+    int spins = 0;
+    ULONG head = stripQueue.head;
+    while (head - stripQueue.tail >= PIPELINE_QUEUE) SpinPause(spins, stripPopped);
+
+    StripDone& item = stripQueue.items[head & (PIPELINE_QUEUE - 1)];
+    item.strip = strip;
+    item.scaleStart = scaleStart;
+    item.scaleEnd = scaleEnd;
+    InterlockedExchange((volatile LONG*)&stripQueue.head, (LONG)(head + 1));
+    SetEvent(stripPushed);
+}
+
+StripDone PopStrip()
+{
+    int spins = 0;
+    ULONG tail = stripQueue.tail;
+    while (stripQueue.head == tail) SpinPause(spins, stripPushed);
+
+    StripDone item = stripQueue.items[tail & (PIPELINE_QUEUE - 1)];
+    InterlockedExchange((volatile LONG*)&stripQueue.tail, (LONG)(tail + 1));
+    SetEvent(stripPopped);
+    return item;
+}
+
+int StripTop(const ScaleJob& job, int strip)
+{
+    return strip * job.height / pipelineStrips;
+}
+
+DWORD WINAPI PipelineWorker(LPVOID)
+{
+    for (;;) {
+        WaitForSingleObject(pipelineStart, INFINITE);
+
+        const ScaleJob& job = pipelineJob;
+        double overlayMs = 0.0;
+        for (int k = 0; k < pipelineStrips; k++) {
+            int top = StripTop(job, k);
+            int bottom = StripTop(job, k + 1);
+            LONGLONG scaleStart = Now();
+            ScaleRows(job, top, bottom);
+            GdiFlush();
+            LONGLONG scaleEnd = Now();
+            if (job.overlay) {
+                overlayMs += DrawOverlay(backBits, backStride, job.width, job.height, top, bottom);
+            }
+            if (k == pipelineStrips - 1) pipelineOverlayMs = overlayMs;
+            PushStrip(k, scaleStart, scaleEnd);
+        }
+    }
+}
+
+void StartPipeline()
+{
+    if (pipelineStrips < 2) pipelineStrips = 2;
+    if (pipelineStrips > PIPELINE_MAX_STRIPS) pipelineStrips = PIPELINE_MAX_STRIPS;
+
+    pipelineStart = CreateEventA(NULL, FALSE, FALSE, NULL);
+    stripPushed = CreateEventA(NULL, FALSE, FALSE, NULL);
+    stripPopped = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (!pipelineStart || !stripPushed || !stripPopped) return;
+
+    pipelineWorker = CreateThread(0, 0, PipelineWorker, 0, 0, 0);
+}
+
+// Average the collected times and print them (view with DebugView).
+// Only used with Report=1 in the [Pipeline] section.
+void ReportPipelineTimes()
+{
+    PipelineTimes& t = pipelineTimes;
+    char line[128];
+
+    wsprintfA(line, "gdi-scaling: %d strips, first strip shown after %d us, frame done after %d us\n",
+              pipelineStrips, (int)(ElapsedMs(0, t.firstShown) * 1000.0 / t.frames),
+              (int)(ElapsedMs(0, t.done) * 1000.0 / t.frames));
+    OutputDebugStringA(line);
+
+    for (int k = 0; k < pipelineStrips; k++) {
+        wsprintfA(line, "gdi-scaling:   strip %d: scale %d us, blit %d us\n", k,
+                  (int)(ElapsedMs(0, t.scale[k]) * 1000.0 / t.frames),
+                  (int)(ElapsedMs(0, t.blit[k]) * 1000.0 / t.frames));
+        OutputDebugStringA(line);
+    }
+
+    memset(&t, 0, sizeof(t));
+}
+
+void PresentPipelined(HDC hdc, const ScaleJob& job, LONGLONG start)
+{
+    // The worker writes the DIB section directly when streaming: flush what
+    // this thread still has batched against it first
+    if (job.stream) GdiFlush();
+
+    pipelineJob = job;
+    SetEvent(pipelineStart);
+
+    // Strips are blitted straight from the back buffer bits with the original
+    // SetDIBitsToDevice, since backDC belongs to the worker until the last strip
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    info.bmiHeader.biWidth = backStride;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    LONGLONG scaled = start;
+    for (int k = 0; k < pipelineStrips; k++) {
+        StripDone done = PopStrip();
+        int top = StripTop(job, done.strip);
+        int rows = StripTop(job, done.strip + 1) - top;
+
+        LONGLONG blitStart = Now();
+        info.bmiHeader.biHeight = -rows;  // top-down
+        ((SetDIBitsToDevice_t)tSDTD)(hdc, 0, top, job.width, rows, 0, 0, 0, rows,
+                                     backBits + (size_t)top * backStride, &info, DIB_RGB_COLORS);
+        LONGLONG blitEnd = Now();
+
+        if (pipelineReport) {
+            pipelineTimes.scale[k] += done.scaleEnd - done.scaleStart;
+            pipelineTimes.blit[k] += blitEnd - blitStart;
+            if (k == 0) pipelineTimes.firstShown += blitEnd - start;
+        }
+        if (done.scaleEnd > scaled) scaled = done.scaleEnd;
+    }
+
+    LONGLONG end = Now();
+    if (pipelineReport) {
+        pipelineTimes.done += end - start;
+        if (++pipelineTimes.frames == PIPELINE_REPORT_FRAMES) {
+            ReportPipelineTimes();
+        }
+    }
+
+    if (job.overlay) {
+        Smooth(frameStats.overlayMs, pipelineOverlayMs);
+    }
+    UpdateFrameStats(start, scaled, end);
+}
+
 // Hooked function: scale the bitmap to fill the window
 int WINAPI hSetDIBitsToDevice(
     HDC hdc, int x, int y, DWORD cx, DWORD cy,
@@ -95,6 +907,16 @@ int WINAPI hSetDIBitsToDevice(
         windowHeight = GetScreenHeight();
     }
     
+    // RLE frames are decoded straight into a cached 8bpp plane instead of
+    // letting GDI expand them into a temporary bitmap before stretching
+    bool isRle = bmi && (bmi->bmiHeader.biCompression == BI_RLE8 ||
+                         bmi->bmiHeader.biCompression == BI_RLE4);
+    bool rleChanged = true;
+    if (isRle && !(windowWidth > 1000 && windowHeight > 600 &&
+                   DecodeRleFrame(bmi, bits, u, &rleChanged))) {
+        return ((SetDIBitsToDevice_t)tSDTD)(hdc, x, y, cx, cy, xs, ys, s, l, bits, bmi, u);
+    }
+
     // ALWAYS scale if the window/DC is fullscreen-sized
     if (windowWidth > 1000 && windowHeight > 600) {
         // Get source dimensions - use the full bitmap size from BITMAPINFO if available
@@ -110,6 +932,12 @@ int WINAPI hSetDIBitsToDevice(
         float scaleX = (float)windowWidth / (float)srcWidth;
         float scaleY = (float)windowHeight / (float)srcHeight;
         float scale = (scaleX < scaleY) ? scaleX : scaleY;  // Use smaller scale to fit
+
+        // The integer tier snaps to a whole multiple: fewer pixels, pixel exact
+        int tier = governorEnabled ? governor.tier : TIER_NEAREST;
+        if (tier == TIER_INTEGER && scale >= 1.0f) {
+            scale = (float)(int)scale;
+        }
         
         int dstWidth = (int)(srcWidth * scale);
         int dstHeight = (int)(srcHeight * scale);
@@ -117,39 +945,70 @@ int WINAPI hSetDIBitsToDevice(
         // Center the image
         int dstX = (windowWidth - dstWidth) / 2;
         int dstY = (windowHeight - dstHeight) / 2;
-        
-        // Create memory DC for double buffering to eliminate flicker
-        HDC memDC = CreateCompatibleDC(hdc);
-        HBITMAP memBitmap = CreateCompatibleBitmap(hdc, windowWidth, windowHeight);
-        HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, memBitmap);
-        
-        // Fill background with black in memory DC
+
+        // Scale from the decoded plane; a delta frame that skipped every pixel
+        // leaves the previous frame on screen untouched
+        if (isRle) {
+            if (!rleChanged) return dstHeight;
+            bits = rlePlane;
+            bmi = (const BITMAPINFO*)&rleInfo;
+        }
+
+        PublishFrame(bits, bmi, u);
+
+        // Timing is only taken when the overlay, governor or pipeline uses it
+        bool timing = overlayEnabled || governorEnabled || pipelineWorker != NULL;
+        LONGLONG start = timing ? Now() : 0;
+
+        // Cheapest tier: let GDI draw the frame unscaled, clearing the
+        // last scaled frame once when switching to it
         RECT fullRect = {0, 0, windowWidth, windowHeight};
-        FillRect(memDC, &fullRect, (HBRUSH)GetStockObject(BLACK_BRUSH));
-        
-        // Draw scaled image to memory DC
-        SetStretchBltMode(memDC, COLORONCOLOR);  // Faster, better for pixel art
-        
-        StretchDIBits(
-            memDC,
-            dstX, dstY,
-            dstWidth, dstHeight,
-            0, 0,  // Use full source bitmap
-            srcWidth, srcHeight,
-            bits,
-            bmi,
-            u,
-            SRCCOPY
-        );
-        
+        if (tier == TIER_GDI) {
+            if (presentedTier != TIER_GDI) {
+                FillRect(hdc, &fullRect, (HBRUSH)GetStockObject(BLACK_BRUSH));
+            }
+            presentedTier = tier;
+            int result = ((SetDIBitsToDevice_t)tSDTD)(hdc, x, y, cx, cy, xs, ys, s, l, bits, bmi, u);
+            LONGLONG end = Now();
+            UpdateFrameStats(start, end, end);
+            return result;
+        }
+        presentedTier = tier;
+
+        // Cached back buffer for double buffering to eliminate flicker
+        if (!EnsureBackBuffer(hdc, windowWidth, windowHeight)) {
+            return ((SetDIBitsToDevice_t)tSDTD)(hdc, x, y, cx, cy, xs, ys, s, l, bits, bmi, u);
+        }
+
+        ScaleJob job = { bits, bmi, u, srcWidth, srcHeight, dstX, dstY, dstWidth, dstHeight,
+                         windowWidth, windowHeight, tier, false, false };
+        job.stream = PrepareStreaming(job);
+        if (overlayEnabled) {
+            PollOverlayHotkey();
+            job.overlay = overlayVisible;
+        }
+
+        if (pipelineWorker) {
+            PresentPipelined(hdc, job, start);
+            return dstHeight;
+        }
+
+        ScaleRows(job, 0, windowHeight);
+
+        // Blend the overlay into the finished frame before it is presented
+        LONGLONG scaled = timing ? Now() : 0;
+        if (job.overlay) {
+            GdiFlush();
+            Smooth(frameStats.overlayMs, DrawOverlay(backBits, backStride, windowWidth, windowHeight, 0, windowHeight));
+        }
+
         // Copy complete frame from memory DC to screen in one operation (no flicker!)
-        BitBlt(hdc, 0, 0, windowWidth, windowHeight, memDC, 0, 0, SRCCOPY);
-        
-        // Cleanup
-        SelectObject(memDC, oldBitmap);
-        DeleteObject(memBitmap);
-        DeleteDC(memDC);
-        
+        BitBlt(hdc, 0, 0, windowWidth, windowHeight, backDC, 0, 0, SRCCOPY);
+
+        if (timing) {
+            UpdateFrameStats(start, scaled, Now());
+        }
+
         return dstHeight;
     }
     
@@ -217,6 +1076,14 @@ BOOL LoadOriginalWinmm()
 DWORD WINAPI Init(LPVOID)
 {
     Sleep(500);  // Give the game time to create its window
+    LoadSettings();
+    GovernorReset(governor, governorBudgetMs, TIER_NEAREST);
+    if (pipelineEnabled) {
+        StartPipeline();
+    }
+    if (frameTapEnabled) {
+        OpenFrameTap();
+    }
     HookSetDIBitsToDevice();
     return 0;
 }
@@ -226,6 +1093,7 @@ BOOL WINAPI DllMain(HINSTANCE h, DWORD r, LPVOID)
     if(r == DLL_PROCESS_ATTACH)
     {
         DisableThreadLibraryCalls(h);
+        hThisModule = h;
         
         // Load the original winmm.dll
         if (!LoadOriginalWinmm()) {
@@ -239,6 +1107,7 @@ BOOL WINAPI DllMain(HINSTANCE h, DWORD r, LPVOID)
     }
     else if (r == DLL_PROCESS_DETACH)
     {
+        CloseFrameTap();
         if (hOriginalWinmm) {
             FreeLibrary(hOriginalWinmm);
         }
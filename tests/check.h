@@ -0,0 +1,30 @@
+// Minimal check helpers shared by the tests in this directory.
+#pragma once
+
+#include <stdio.h>
+
+inline int& CheckFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+// Records a failure and keeps going, so one run reports every broken check
+inline void Check(bool ok, const char* what)
+{
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what);
+        CheckFailures()++;
+    }
+}
+
+// Prints the verdict for test name; returns main()'s exit code
+inline int CheckResult(const char* name)
+{
+    if (CheckFailures()) {
+        fprintf(stderr, "%s: %d failures\n", name, CheckFailures());
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Stress test for the frame tap sequence protocol (src/frametap.h).
+//
+// The ring lives in POSIX shared memory. A forked writer process publishes
+// frames as fast as it can into a deliberately small ring, stamping every
+// pixel word with the frame number; the parent reads the newest frame in
+// place, as tapreader does, yielding halfway through every other read. Any
+// frame that FrameTapEndRead accepts must be consistent, and the torn frames
+// the reader does see must all have been rejected.
+//
+// A deterministic single-process case checks the lapped-reader path and
+// the counter wrap on every run, independent of scheduling.
+#include "frametap.h"
+#include "check.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static const uint32_t kSlots = 2;
+static const uint32_t kPixelBytes = 64 * 1024;
+static const double kSeconds = 1.0;
+
+static size_t RingSize()
+{
+    size_t slotSize = (sizeof(FrameTapSlot) + kPixelBytes + 63) & ~(size_t)63;
+    return sizeof(FrameTapHeader) + kSlots * slotSize;
+}
+
+static void InitRing(FrameTapHeader* tap)
+{
+    tap->slotCount = kSlots;
+    tap->slotSize = (uint32_t)((sizeof(FrameTapSlot) + kPixelBytes + 63) & ~(size_t)63);
+    tap->latest.store(0, std::memory_order_relaxed);
+    tap->dropped.store(0, std::memory_order_relaxed);
+    tap->version = FRAMETAP_VERSION;
+    tap->magic.store(FRAMETAP_MAGIC, std::memory_order_release);
+}
+
+static void WriteFrame(FrameTapHeader* tap, uint32_t frame)
+{
+    FrameTapSlot* slot = FrameTapBeginWrite(tap, frame);
+    slot->format.width = (int32_t)frame;
+    slot->format.sizeImage = kPixelBytes;
+    uint32_t* pixels = (uint32_t*)FrameTapPixels(slot);
+    for (uint32_t i = 0; i < kPixelBytes / 4; i++) {
+        // Relaxed atomic stores: the payload races with readers by design
+        __atomic_store_n(&pixels[i], frame, __ATOMIC_RELAXED);
+    }
+    FrameTapEndWrite(tap, slot, frame);
+}
+
+// Reads the slot in place. Returns true if every word belongs to frame.
+// Yielding halfway lets the writer lap the reader even on a single CPU.
+static bool ReadConsistent(const FrameTapSlot* slot, uint32_t frame, bool yieldHalfway = false)
+{
+    bool consistent = slot->format.width == (int32_t)frame;
+    const uint32_t* pixels = (const uint32_t*)FrameTapPixels(slot);
+    for (uint32_t i = 0; i < kPixelBytes / 4; i++) {
+        if (yieldHalfway && i == kPixelBytes / 8) sched_yield();
+        if (__atomic_load_n(&pixels[i], __ATOMIC_RELAXED) != frame) consistent = false;
+    }
+    return consistent;
+}
+
+static void Deterministic()
+{
+    std::vector<uint64_t> memory(RingSize() / 8 + 1, 0);
+    FrameTapHeader* tap = (FrameTapHeader*)memory.data();
+    InitRing(tap);
+
+    // Slots and pixel data sit on 64-byte boundaries of the mapping
+    for (uint32_t frame = 1; frame <= kSlots; frame++) {
+        size_t offset = FrameTapPixels(FrameTapGetSlot(tap, frame)) - (uint8_t*)tap;
+        Check(offset % 64 == 0, "pixel data not 64-byte aligned");
+    }
+
+    Check(FrameTapBeginRead(tap, 1) == NULL, "empty slot readable");
+
+    WriteFrame(tap, 1);
+    const FrameTapSlot* slot = FrameTapBeginRead(tap, 1);
+    Check(slot != NULL, "complete frame not readable");
+    Check(slot && ReadConsistent(slot, 1), "complete frame inconsistent");
+    Check(slot && FrameTapEndRead(slot, 1), "undisturbed read rejected");
+
+    // The writer laps the reader: frame 1 + kSlots lands in the same slot
+    slot = FrameTapBeginRead(tap, 1);
+    FrameTapSlot* same = FrameTapBeginWrite(tap, 1 + kSlots);
+    Check(slot == same, "frames kSlots apart share a slot");
+    Check(!FrameTapEndRead(slot, 1), "read during overwrite accepted");
+    FrameTapEndWrite(tap, same, 1 + kSlots);
+    Check(!FrameTapEndRead(slot, 1), "read after overwrite accepted");
+    Check(FrameTapBeginRead(tap, 1) == NULL, "overwritten frame still readable");
+
+    // Frame numbers wrap to 1, never 0, and sequences stay odd/even
+    Check(FrameTapNext(0xFFFFFFFFu) == 1, "frame counter wrap");
+    Check((FrameTapBusy(0x80000000u) & 1) == 1, "busy sequence odd after wrap");
+    Check(FrameTapDone(0x80000001u) == 2, "done sequence wraps");
+    WriteFrame(tap, 0xFFFFFFFFu);
+    slot = FrameTapBeginRead(tap, 0xFFFFFFFFu);
+    Check(slot && ReadConsistent(slot, 0xFFFFFFFFu) && FrameTapEndRead(slot, 0xFFFFFFFFu),
+          "frame 0xFFFFFFFF readable");
+}
+
+static double Seconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void Stress()
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/gdi_scaling_framering_%d", (int)getpid());
+    size_t size = RingSize();
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        // Sandboxes without /dev/shm: nothing to stress
+        printf("framering_test: shm_open unavailable, stress test skipped\n");
+        if (fd >= 0) close(fd);
+        shm_unlink(name);
+        return;
+    }
+    FrameTapHeader* tap = (FrameTapHeader*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    Check(tap != MAP_FAILED, "mmap");
+    if (tap == MAP_FAILED) return;
+    InitRing(tap);
+
+    pid_t writer = fork();
+    if (writer == 0) {
+        // Writer maps the ring by name, like a separate process would
+        int wfd = shm_open(name, O_RDWR, 0);
+        FrameTapHeader* wtap = (FrameTapHeader*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, wfd, 0);
+        if (wtap == MAP_FAILED) _exit(1);
+        uint32_t frame = 0;
+        for (;;) {
+            frame = FrameTapNext(frame);
+            WriteFrame(wtap, frame);
+        }
+    }
+    Check(writer > 0, "fork");
+
+    uint32_t accepted = 0;
+    uint32_t tornDiscarded = 0;
+    uint32_t cleanDiscarded = 0;
+    uint32_t lastFrame = 0;
+    uint32_t reads = 0;
+    double end = Seconds() + kSeconds;
+    while (Seconds() < end) {
+        uint32_t frame = tap->latest.load(std::memory_order_acquire);
+        if (frame == 0 || frame == lastFrame) continue;
+        const FrameTapSlot* slot = FrameTapBeginRead(tap, frame);
+        if (!slot) continue;
+        bool consistent = ReadConsistent(slot, frame, (++reads & 1) != 0);
+        if (FrameTapEndRead(slot, frame)) {
+            Check(consistent, "torn frame accepted");
+            Check(frame - lastFrame < 0x80000000u, "frames went backwards");
+            lastFrame = frame;
+            accepted++;
+        } else if (!consistent) {
+            tornDiscarded++;
+        } else {
+            cleanDiscarded++;
+        }
+    }
+
+    kill(writer, SIGKILL);
+    waitpid(writer, NULL, 0);
+    munmap(tap, size);
+    shm_unlink(name);
+
+    printf("framering_test: %u frames accepted, %u torn frames discarded, %u lapped but intact\n",
+           accepted, tornDiscarded, cleanDiscarded);
+    Check(accepted > 0, "no frame accepted");
+    Check(tornDiscarded > 0, "writer never lapped the reader");
+}
+
+int main()
+{
+    Deterministic();
+    Stress();
+    return CheckResult("framering_test");
+}
@@ -0,0 +1,110 @@
+// Trace-driven tests for the quality governor (src/governor.h).
+//
+// Each trace gives the cost of a present per tier as a function of the frame
+// number; the governor is fed the cost of whatever tier it picked, exactly
+// as the hook does. The traces model 60 fps, so 36000 frames are 10 minutes.
+#include "governor.h"
+#include "check.h"
+
+#include <stdio.h>
+
+typedef double (*CostFn)(int tier, int frame);
+
+struct TraceResult {
+    int switches;
+    int finalTier;
+    int maxUpAfter;
+    int finalUpAfter;
+    int framesPerTier[TIER_COUNT];
+};
+
+static TraceResult Run(CostFn cost, int frames, double budgetMs, int startTier)
+{
+    Governor g;
+    GovernorReset(g, budgetMs, startTier);
+    TraceResult r = {};
+    int tier = g.tier;
+    for (int f = 0; f < frames; f++) {
+        r.framesPerTier[tier]++;
+        int next = GovernorUpdate(g, cost(tier, f));
+        if (next != tier) r.switches++;
+        if (g.upAfter > r.maxUpAfter) r.maxUpAfter = g.upAfter;
+        tier = next;
+    }
+    r.finalTier = tier;
+    r.finalUpAfter = g.upAfter;
+    return r;
+}
+
+static double Cheap(int tier)
+{
+    static const double costs[TIER_COUNT] = { 3.0, 2.0, 1.5, 0.5 };
+    return costs[tier];
+}
+
+// Smooth alternates 7.0/9.5 ms every 200 frames against an 8 ms budget
+static double Oscillating(int tier, int frame)
+{
+    if (tier == TIER_SMOOTH) return ((frame / 200) & 1) ? 9.5 : 7.0;
+    return Cheap(tier);
+}
+
+// Everything is cheap: climb to smooth and stay there
+static double Light(int tier, int /*frame*/)
+{
+    return Cheap(tier) * 0.5;
+}
+
+// Nearest sits between half the budget and the budget: hold it
+static double InBand(int tier, int /*frame*/)
+{
+    static const double costs[TIER_COUNT] = { 11.0, 6.0, 5.0, 0.5 };
+    return costs[tier];
+}
+
+// Only the unscaled tier fits the budget
+static double Overloaded(int tier, int /*frame*/)
+{
+    static const double costs[TIER_COUNT] = { 20.0, 12.0, 9.0, 0.5 };
+    return costs[tier];
+}
+
+// Oscillation for two minutes, then smooth becomes cheap for good
+static double Settling(int tier, int frame)
+{
+    if (frame < 7200) return Oscillating(tier, frame);
+    return Cheap(tier) * 0.5;
+}
+
+int main()
+{
+    // The reported case: the old governor switched tiers 360 times here
+    TraceResult r = Run(Oscillating, 36000, 8.0, TIER_NEAREST);
+    printf("oscillating: %d switches, upAfter %d, %d frames smooth, %d nearest\n",
+           r.switches, r.finalUpAfter, r.framesPerTier[TIER_SMOOTH], r.framesPerTier[TIER_NEAREST]);
+    Check(r.switches <= 40, "oscillating: governor flaps");
+    Check(r.maxUpAfter == GOVERNOR_UP_MAX, "oscillating: failed step ups don't back off");
+    Check(r.framesPerTier[TIER_SMOOTH] < 36000 / 10, "oscillating: too long over budget in smooth");
+    Check(r.framesPerTier[TIER_INTEGER] == 0 && r.framesPerTier[TIER_GDI] == 0,
+          "oscillating: dropped below nearest");
+
+    r = Run(Light, 36000, 8.0, TIER_NEAREST);
+    Check(r.switches == 1 && r.finalTier == TIER_SMOOTH, "light: doesn't settle on smooth");
+    Check(r.finalUpAfter == GOVERNOR_UP_AFTER, "light: upAfter grew");
+
+    r = Run(InBand, 36000, 8.0, TIER_NEAREST);
+    Check(r.switches == 0, "in band: switched tiers");
+
+    r = Run(Overloaded, 36000, 8.0, TIER_SMOOTH);
+    printf("overloaded: %d switches, %d frames unscaled\n", r.switches, r.framesPerTier[TIER_GDI]);
+    Check(r.framesPerTier[TIER_GDI] > 36000 * 9 / 10, "overloaded: not mostly unscaled");
+    Check(r.switches <= 30, "overloaded: governor flaps");
+
+    // The back-off isn't permanent: once smooth fits it returns and the wait relaxes
+    r = Run(Settling, 36000, 8.0, TIER_NEAREST);
+    printf("settling: %d switches, final tier %d, upAfter %d\n", r.switches, r.finalTier, r.finalUpAfter);
+    Check(r.finalTier == TIER_SMOOTH, "settling: never returns to smooth");
+    Check(r.finalUpAfter == GOVERNOR_UP_AFTER, "settling: upAfter doesn't relax");
+
+    return CheckResult("governor_test");
+}
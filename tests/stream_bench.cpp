@@ -0,0 +1,170 @@
+// Benchmark: ScaleNearestRows with aligned stores against non-temporal
+// (_mm_stream_si128) stores (src/stream.h).
+//
+// Scales a 640x480 8bpp frame into 1920x1080 and 3840x2160 outputs, as the
+// hook does for large windows, and reports output throughput per variant.
+// Cache misses come from perf_event_open where the kernel allows it. Either
+// way the bench also times re-reading the source frame, palette and column
+// map right after each present, which is the working set streaming stores
+// are meant to keep cached.
+#include "stream.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static double Ms(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// Last-level cache miss counter for this thread, or -1 if unavailable
+struct MissCounter {
+    int fd;
+    MissCounter() : fd(-1)
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~MissCounter()
+    {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    void Start()
+    {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    long long Stop()
+    {
+        long long count = -1;
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+        return count;
+    }
+};
+
+// Touches every cache line of the source-side working set
+static uint32_t Reread(const StreamSource& src, const int* columns, int stride)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < src.stride * src.height; i += 64) sum += src.bits[i];
+    for (int i = 0; i < 256; i += 16) sum += src.palette[i];
+    for (int i = 0; i < stride; i += 16) sum += (uint32_t)columns[i];
+    return sum;
+}
+
+struct Result {
+    double scaleMs;
+    double rereadMs;
+    long long misses;
+};
+
+template <bool NonTemporal>
+static Result Run(const StreamSource& src, const int* columns, uint32_t* out, int stride,
+                  int height, int dstY, int dstHeight, int frames, MissCounter& counter)
+{
+    Result r = { 0.0, 0.0, 0 };
+    volatile uint32_t sink = 0;
+    for (int f = 0; f < frames; f++) {
+        counter.Start();
+        Clock::time_point t0 = Clock::now();
+        ScaleNearestRows<NonTemporal>(src, columns, out, stride, dstY, dstHeight, 0, height);
+        Clock::time_point t1 = Clock::now();
+        sink = sink + Reread(src, columns, stride);
+        Clock::time_point t2 = Clock::now();
+        long long misses = counter.Stop();
+        r.scaleMs += Ms(t0, t1);
+        r.rereadMs += Ms(t1, t2);
+        r.misses = (misses < 0 || r.misses < 0) ? -1 : r.misses + misses;
+    }
+    r.scaleMs /= frames;
+    r.rereadMs /= frames;
+    if (r.misses > 0) r.misses /= frames;
+    return r;
+}
+
+static void Print(const char* name, const Result& r, double outBytes)
+{
+    printf("  %-9s scale %7.3f ms  %6.2f GB/s  source reread %6.1f us", name, r.scaleMs,
+           outBytes / (r.scaleMs * 1e-3) / 1e9, r.rereadMs * 1000.0);
+    if (r.misses >= 0) {
+        printf("  %lld cache misses/frame", r.misses);
+    }
+    printf("\n");
+}
+
+static void Bench(int outWidth, int outHeight, int frames)
+{
+    const int srcWidth = 640;
+    const int srcHeight = 480;
+    std::vector<uint8_t> bits((size_t)srcWidth * srcHeight);
+    for (size_t i = 0; i < bits.size(); i++) bits[i] = (uint8_t)(i * 7 + i / srcWidth);
+    uint32_t palette[256];
+    for (int i = 0; i < 256; i++) palette[i] = (uint32_t)i * 0x010101;
+    StreamSource src = { bits.data(), srcWidth, srcWidth, srcHeight, 8, true, palette };
+
+    // Fit 4:3 into the output, centred, like the hook
+    int dstHeight = outHeight;
+    int dstWidth = srcWidth * outHeight / srcHeight;
+    int dstX = (outWidth - dstWidth) / 2;
+    int stride = (outWidth + 3) & ~3;
+    std::vector<int> columns(stride);
+    BuildStreamColumns(columns.data(), stride, srcWidth, dstX, dstWidth);
+
+    std::vector<uint32_t> storage((size_t)stride * outHeight + 4);
+    uint32_t* out = storage.data();
+    while ((uintptr_t)out & 15) out++;
+
+    MissCounter counter;
+    double outBytes = (double)stride * outHeight * 4;
+    printf("%dx%d 8bpp -> %dx%d (%.1f MB per frame), %d frames\n",
+           srcWidth, srcHeight, outWidth, outHeight, outBytes / (1024 * 1024), frames);
+
+    // Warm up both paths, then measure
+    Run<false>(src, columns.data(), out, stride, outHeight, 0, dstHeight, 3, counter);
+    Run<true>(src, columns.data(), out, stride, outHeight, 0, dstHeight, 3, counter);
+    Result aligned = Run<false>(src, columns.data(), out, stride, outHeight, 0, dstHeight, frames, counter);
+    Result streamed = Run<true>(src, columns.data(), out, stride, outHeight, 0, dstHeight, frames, counter);
+
+    Print("aligned", aligned, outBytes);
+    Print("streaming", streamed, outBytes);
+    if (counter.fd < 0) {
+        printf("  (perf_event_open unavailable: no cache miss counts)\n");
+    }
+}
+
+int main()
+{
+    Bench(1920, 1080, 200);
+    Bench(3840, 2160, 100);
+    return 0;
+}